@@ -0,0 +1,222 @@
+/*************************************************************************************
+ * MIT License                                                                       *
+ *                                                                                   *
+ * Copyright (C) 2016 Charly Lamothe, Stéphane Arcellier                             *
+ *                                                                                   *
+ * This file is part of LCompiler.                                                   *
+ *                                                                                   *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy    *
+ *   of this software and associated documentation files (the "Software"), to deal   *
+ *   in the Software without restriction, including without limitation the rights    *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell       *
+ *   copies of the Software, and to permit persons to whom the Software is           *
+ *   furnished to do so, subject to the following conditions:                        *
+ *                                                                                   *
+ *   The above copyright notice and this permission notice shall be included in all  *
+ *   copies or substantial portions of the Software.                                 *
+ *                                                                                   *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE     *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE   *
+ *   SOFTWARE.                                                                       *
+ *************************************************************************************/
+
+/**
+ * Benchmark of the analysis: each source file is compiled several times, from
+ * the creation of its analysis to its destruction, MIPS included, and the best
+ * time is printed. No dump is asked. --traced parses with the traced build
+ * of the recursive descent parser, which writes nothing without dump. --lex
+ * only times the creation of the analysis and the lexing of the whole source,
+ * and prints its throughput. --scan forces the kernels of the lexer (see l_scan.h).
+ *
+ * The allocations of the last compilation are counted too: the benchmark is
+ * linked with --wrap of malloc, calloc and realloc (see the Makefile), so
+ * the calls of the compiler go through the counters below. The allocations
+ * of the C library itself (strdup, fopen) aren't counted.
+ *
+ * Usage: l_analysis_bench [--runs <n>] [--jobs <n>] [--ll1] [--traced] [--lex]
+ *                         [--scan scalar|sse2|avx2] <source_file>...
+ */
+
+/* Required by clock_gettime() with -std=c99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "../headers/l_analysis.h"
+#include "../headers/l_lexical_analysis.h"
+#include "../headers/l_scan.h"
+#include "../headers/thread_storage.h"
+#include "../headers/stacktrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t number, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+/* Updated by the threads of the parallel parser too */
+static unsigned long allocations = 0;
+
+void *__wrap_malloc(size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t number, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_calloc(number, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_realloc(pointer, size);
+}
+
+typedef struct {
+    int runs;
+    int jobs;
+    bool ll1_parser;
+    bool traced_parser;
+    bool lex_only;
+} bench_options;
+
+static double now() {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/* Time of one compilation of the file, or a negative time if it failed */
+static double compile(const char *file_name, bench_options *options, int *errors_number) {
+    l_analysis_ctx *ctx;
+    double start, end;
+    bool processed;
+
+    allocations = 0;
+    start = now();
+
+    if (!l_analysis_create_from_path(&ctx, file_name)) {
+        return -1;
+    }
+    if (options->lex_only) {
+        processed = l_lexical_analysis_tokenize(ctx);
+        *errors_number = 0;
+        l_analysis_destroy(ctx);
+        end = now();
+        return processed ? end - start : -1;
+    }
+    if (options->ll1_parser) {
+        l_analysis_use_ll1_parser(ctx);
+    }
+    if (options->traced_parser) {
+        l_analysis_use_traced_parser(ctx);
+    }
+    if (options->jobs) {
+        l_analysis_set_jobs(ctx, options->jobs);
+    }
+    processed = l_analysis_process(ctx);
+    *errors_number = l_analysis_get_errors_number(ctx);
+    l_analysis_destroy(ctx);
+
+    end = now();
+
+    return processed ? end - start : -1;
+}
+
+/* Size of the file in bytes, or a negative size if it can't be read */
+static long file_size(const char *file_name) {
+    FILE *file;
+    long size;
+
+    if (!(file = fopen(file_name, "rb"))) {
+        return -1;
+    }
+    size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    fclose(file);
+
+    return size;
+}
+
+static bool bench_file(const char *file_name, bench_options *options) {
+    double time, best;
+    int i, errors_number;
+
+    best = -1;
+    errors_number = 0;
+
+    for (i = 0; i < options->runs; i++) {
+        if ((time = compile(file_name, options, &errors_number)) < 0) {
+            fprintf(stderr, "%s: failed to compile\n", file_name);
+            return false;
+        }
+        if (best < 0 || time < best) {
+            best = time;
+        }
+    }
+
+    fprintf(stdout, "%-40s %10.4f s (best of %d), %lu allocations", file_name, best, options->runs, allocations);
+    if (options->lex_only && best > 0) {
+        fprintf(stdout, ", %.0f MB/s", file_size(file_name) / best / 1e6);
+    }
+    if (errors_number > 0) {
+        fprintf(stdout, ", %d errors", errors_number);
+    }
+    fprintf(stdout, "\n");
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bench_options options;
+    int i;
+    bool succeeded;
+
+    options.runs = 10;
+    options.jobs = 0;
+    options.ll1_parser = false;
+    options.traced_parser = false;
+    options.lex_only = false;
+    succeeded = true;
+
+    thread_storage_init();
+
+    for (i = 1; i < argc && strncmp(argv[i], "--", 2) == 0; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc && (options.runs = atoi(argv[i + 1])) > 0) {
+            i++;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc && (options.jobs = atoi(argv[i + 1])) > 0) {
+            i++;
+        } else if (strcmp(argv[i], "--ll1") == 0) {
+            options.ll1_parser = true;
+        } else if (strcmp(argv[i], "--traced") == 0) {
+            options.traced_parser = true;
+        } else if (strcmp(argv[i], "--lex") == 0) {
+            options.lex_only = true;
+        } else if (strcmp(argv[i], "--scan") == 0 && i + 1 < argc && l_scan_kernels_force(argv[i + 1])) {
+            i++;
+        } else {
+            break;
+        }
+    }
+
+    if (i == argc || strncmp(argv[i], "--", 2) == 0) {
+        fprintf(stderr, "Usage: %s [--runs <n>] [--jobs <n>] [--ll1] [--traced] [--lex] [--scan scalar|sse2|avx2] <source_file>...\n", argv[0]);
+        thread_storage_uninit();
+        return EXIT_FAILURE;
+    }
+
+    for (; i < argc; i++) {
+        succeeded = bench_file(argv[i], &options) && succeeded;
+    }
+
+    stacktrace_print();
+    thread_storage_uninit();
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}